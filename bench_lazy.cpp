@@ -0,0 +1,111 @@
+#include <openfhe/binfhe/binfhecontext.h>
+#include <openfhe/core/math/hal/intnat/lazyvecops.h>
+#include <benchmark/benchmark.h>
+
+using namespace lbcrypto;
+
+// microbenchmark of the lazy accumulation kernels used by RLWE packing (FunctionalKeySwitch)
+// range(0): instruction set (0 = scalar, 1 = AVX2, 2 = AVX-512), range(1): vector length
+
+NativeInteger Q53 = PreviousPrime<NativeInteger>(FirstPrime<NativeInteger>(53, 1 << 12), 1 << 12);
+
+// number of key rows accumulated per iteration, roughly one LWE coefficient worth of digits
+const size_t n_rows = 64;
+
+static std::vector<NativeVector> random_rows(size_t N)
+{
+    DiscreteUniformGeneratorImpl<NativeVector> dug;
+    dug.SetModulus(Q53);
+    std::vector<NativeVector> rows(n_rows);
+    for (auto &row : rows)
+        row = dug.GenerateVector(N, Q53);
+    return rows;
+}
+
+static bool set_isa(benchmark::State &st)
+{
+    auto isa = static_cast<intnat::LazyKernelISA>(st.range(0));
+    intnat::SetLazyKernelISA(isa);
+    if (intnat::GetLazyKernelISA() != isa)
+    {
+        st.SkipWithError("instruction set not supported by this CPU");
+        return false;
+    }
+    return true;
+}
+
+// baseline: modular subtraction, as done before the lazy scheme
+static void ModSubEq(benchmark::State &st)
+{
+    size_t N = st.range(1);
+    auto rows = random_rows(N);
+    NativeVector acc(N, Q53);
+    for (auto _ : st)
+    {
+        for (auto &row : rows)
+            acc.ModSubEq(row);
+        benchmark::DoNotOptimize(acc);
+    }
+    st.SetItemsProcessed(st.iterations() * n_rows * N);
+}
+
+static void SubEq(benchmark::State &st)
+{
+    if (!set_isa(st))
+        return;
+    size_t N = st.range(1);
+    auto rows = random_rows(N);
+    NativeVector acc(N, Q53);
+    for (auto _ : st)
+    {
+        for (auto &row : rows)
+            acc.SubEq(row);
+        benchmark::DoNotOptimize(acc);
+    }
+    st.SetItemsProcessed(st.iterations() * n_rows * N);
+}
+
+static void ModReduce(benchmark::State &st)
+{
+    if (!set_isa(st))
+        return;
+    size_t N = st.range(1);
+    NativeVector acc(N, Q53);
+    for (size_t i = 0; i < N; i++)
+        acc[i] = uint64_t(-1) - i;
+    for (auto _ : st)
+    {
+        NativeVector tmp = acc;
+        tmp.ModReduce();
+        benchmark::DoNotOptimize(tmp);
+    }
+    st.SetItemsProcessed(st.iterations() * N);
+}
+
+// the packing inner loop: subtract key rows, reduce every max_add_count rows (fused)
+static void SubEqLazy(benchmark::State &st)
+{
+    if (!set_isa(st))
+        return;
+    size_t N = st.range(1);
+    auto rows = random_rows(N);
+    uint64_t max_add_count = uint64_t(-1) / Q53.ConvertToInt() - 1;
+    NativeInteger max_sub_buffer = max_add_count * Q53;
+    NativeVector acc(N, Q53);
+    for (size_t i = 0; i < N; i++)
+        acc[i] = max_sub_buffer;
+    uint64_t ctr = 0;
+    for (auto _ : st)
+    {
+        for (auto &row : rows)
+            ctr = acc.SubEqLazy(&row[0], ctr, max_add_count, max_sub_buffer);
+        benchmark::DoNotOptimize(acc);
+    }
+    st.SetItemsProcessed(st.iterations() * n_rows * N);
+}
+
+BENCHMARK(ModSubEq)->ArgsProduct({{0}, {1 << 10, 1 << 11}});
+BENCHMARK(SubEq)->ArgsProduct({{0, 1, 2}, {1 << 10, 1 << 11}});
+BENCHMARK(ModReduce)->ArgsProduct({{0, 1, 2}, {1 << 10, 1 << 11}});
+BENCHMARK(SubEqLazy)->ArgsProduct({{0, 1, 2}, {1 << 10, 1 << 11}});
+BENCHMARK_MAIN();
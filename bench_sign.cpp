@@ -1,4 +1,5 @@
 #include <openfhe/binfhe/binfhecontext.h>
+#include <openfhe/binfhe/binfhe-planner.h>
 #include <benchmark/benchmark.h>
 
 using namespace lbcrypto;
@@ -14,64 +15,61 @@ enum DecompType
     COMPRESS
 };
 
-std::vector<uint32_t> get_bases(DecompType decomp_type, uint64_t qin)
+struct ParamSet
 {
-    switch (decomp_type)
+    std::string desc;
+    DecompType dec_type;
+    uint32_t p;
+    // basic scheme params
+    uint32_t n;
+    uint32_t N;
+    NativeInteger q;
+    NativeInteger Q;
+    NativeInteger qKS;
+    double std;
+    uint32_t baseKS;
+    uint32_t baseR;
+    // extra params
+    uint32_t beta_precise;
+};
+
+// gadget bases the planner chooses from
+std::vector<uint32_t> candidate_bases = {1 << 14, 1 << 18, 1 << 27};
+
+// floor algorithm of the decomposition of a qin-bit input
+FloorMethod get_floor_method(const ParamSet &param_set, uint64_t qin)
+{
+    switch (param_set.dec_type)
     {
     case LMP22:
         if (qin > 1 << 29)
             OPENFHE_THROW(openfhe_error, "max qin = 2^29");
-        if (qin >= 1 << 26)
-            return {1 << 14, 1 << 18, 1 << 27};
-        if (qin >= 1 << 17)
-            return {1 << 18, 1 << 27};
-        return {1 << 27};
+        return FloorMethod::FLOOR;
     case LMP22ALT:
         if (qin > uint64_t(1) << 31)
             OPENFHE_THROW(openfhe_error, "max qin = 2^31");
-        if (qin >= 1 << 28)
-            return {1 << 14, 1 << 18, 1 << 27};
-        if (qin >= 1 << 20)
-            return {1 << 18, 1 << 27};
-        return {1 << 27};
+        return FloorMethod::FLOOR_ALT;
     case REDUCE:
         if (qin > uint64_t(1) << 31)
             OPENFHE_THROW(openfhe_error, "max qin = 2^31");
-        if (qin >= 1 << 29)
-            return {1 << 14, 1 << 18, 1 << 27};
-        if (qin >= 1 << 20)
-            return {1 << 18, 1 << 27};
-        return {1 << 27};
+        return FloorMethod::FLOOR_NEW;
     case COMPRESS:
         if (qin > uint64_t(1) << 33)
             OPENFHE_THROW(openfhe_error, "max qin = 2^33");
-        if (qin >= 1 << 30)
-            return {1 << 14, 1 << 18, 1 << 27};
-        if (qin >= 1 << 21)
-            return {1 << 18, 1 << 27};
-        return {1 << 27};
+        return FloorMethod::FLOOR_COMPRESS;
     default:
         OPENFHE_THROW(openfhe_error, "unrecognized case");
     }
 }
 
-struct ParamSet
+// keys the context generates to decompose a qin-bit input: the gadget base of every level is chosen with the noise
+// and cost models of param.py
+std::vector<uint32_t> get_bases(const ParamSet &param_set, uint64_t qin)
 {
-    std::string desc;
-    DecompType dec_type;
-    uint32_t p;
-    // basic scheme params
-    uint32_t n;
-    uint32_t N;
-    NativeInteger q;
-    NativeInteger Q;
-    NativeInteger qKS;
-    double std;
-    uint32_t baseKS;
-    uint32_t baseR;
-    // extra params
-    uint32_t beta_precise;
-};
+    GadgetBasePlanner planner(param_set.n, param_set.N, param_set.Q, param_set.qKS, param_set.baseKS, param_set.std);
+    NativeInteger beta = (param_set.q.ConvertToInt() + param_set.p) / (2 * param_set.p); // same as BinFHEContext
+    return planner.Plan(qin, param_set.q, get_floor_method(param_set, qin), beta, candidate_bases).KeyBases();
+}
 
 std::vector<ParamSet> param_sets = {
     {"Decomposition Using HomFloor", LMP22, 16, n35, 1 << 11, 1 << 12, Q53, uint64_t(1) << 35, 3.19, 1 << 5, 0, 55},
@@ -79,12 +77,44 @@ std::vector<ParamSet> param_sets = {
     {"Decomposition Using HomDecomp-Reduce", REDUCE, 16, n35, 1 << 11, 1 << 12, Q53, uint64_t(1) << 35, 3.19, 1 << 5, 0, 55},
     {"Decomposition Using HomDecomp-FDFB", COMPRESS, 32, n35, 1 << 11, 1 << 12, Q53, uint64_t(1) << 35, 3.19, 1 << 5, 0, 55}};
 
+int64_t find_param_set(DecompType dec_type)
+{
+    for (size_t i = 0; i < param_sets.size(); i++)
+        if (param_sets[i].dec_type == dec_type)
+            return i;
+    OPENFHE_THROW(openfhe_error, "no parameter set for this decomposition");
+}
+
 class MyFixture : public benchmark::Fixture
 {
 public:
     int64_t cur_param_set_id = -1;
+    std::vector<uint32_t> cur_baseGs;
     BinFHEContext cc;
     LWEPrivateKey sk;
+
+    // regenerates the context and keys when the parameter set or the gadget bases needed for qin change
+    void select_param_set(int64_t param_idx, uint64_t qin)
+    {
+        ParamSet param_set = param_sets[param_idx];
+
+        std::vector<uint32_t> baseGs = get_bases(param_set, qin);
+        if (param_idx != cur_param_set_id || baseGs != cur_baseGs)
+        {
+            cur_param_set_id = param_idx;
+            cur_baseGs = baseGs;
+            std::cout << "select param set = " << param_set.desc << '\n';
+            cc = BinFHEContext();
+            // the context plans the same bases and generates their keys in BTKeyGen
+            cc.GenerateBinFHEContext(param_set.n, param_set.N, param_set.q, param_set.Q, param_set.qKS, param_set.std,
+                                     param_set.baseKS, param_set.baseR, param_set.p, qin, get_floor_method(param_set, qin),
+                                     candidate_bases);
+            // Generate the secret key
+            sk = cc.KeyGen();
+            // Generate the bootstrapping keys (refresh and switching keys)
+            cc.BTKeyGen(sk);
+        }
+    }
 };
 
 BENCHMARK_DEFINE_F(MyFixture, SignTest)
@@ -93,21 +123,7 @@ BENCHMARK_DEFINE_F(MyFixture, SignTest)
     uint64_t qin = uint64_t(1) << st.range(0);
     int64_t param_idx = st.range(1);
     ParamSet param_set = param_sets[param_idx];
-
-    std::vector<uint32_t> baseGs = get_bases(param_set.dec_type, qin);
-    auto B_g = baseGs[0];
-    if (param_idx != cur_param_set_id)
-    {
-        cur_param_set_id = param_idx;
-        std::cout << "select param set = " << param_set.desc << '\n';
-        cc = BinFHEContext();
-        cc.GenerateBinFHEContext(param_set.n, param_set.N, param_set.q, param_set.Q, param_set.qKS, param_set.std,
-                                 param_set.baseKS, B_g, param_set.baseR, 0, 0, 0, 0, 0, param_set.p, baseGs, 0, false, 0, 0, GINX);
-        // Generate the secret key
-        sk = cc.KeyGen();
-        // Generate the bootstrapping keys (refresh and switching keys)
-        cc.BTKeyGen(sk);
-    }
+    select_param_set(param_idx, qin);
     /**
      * parameter sets
      * n = n35
@@ -187,6 +203,38 @@ BENCHMARK_DEFINE_F(MyFixture, SignTest)
     }
 }
 
+// level-synchronous decomposition of a batch of ciphertexts using HomDecomp-Reduce
+BENCHMARK_DEFINE_F(MyFixture, BatchDecompTest)
+(benchmark::State &st)
+{
+    uint64_t qin = uint64_t(1) << st.range(0);
+    size_t batch = st.range(1);
+    int64_t param_idx = find_param_set(REDUCE);
+    ParamSet param_set = param_sets[param_idx];
+    select_param_set(param_idx, qin);
+
+    int factor = 1 << int(log2(qin) - log2(param_set.q.ConvertToInt())); // Q/q
+    int p = cc.GetMaxPlaintextSpace().ConvertToInt() * factor;
+    DiscreteUniformGeneratorImpl<NativeVector> dug;
+    dug.SetModulus(p);
+    std::vector<ConstLWECiphertext> cts(batch);
+    for (auto &ct : cts)
+        ct = cc.Encrypt(sk, dug.GenerateInteger().ConvertToInt(), FRESH, p, qin);
+
+    std::vector<DecompLevelStats> stats;
+    for (auto _ : st)
+    {
+        stats.clear();
+        auto digits = cc.EvalDecompNew(cts, false, &stats);
+        benchmark::DoNotOptimize(digits);
+    }
+    for (auto &level : stats)
+        std::cout << "log2(mod) = " << int(std::ceil(std::log2(level.modulus.ConvertToDouble()))) << ", B_g = 2^"
+                  << int(std::log2(level.baseG)) << ": " << level.Throughput() << " ciphertexts/s\n";
+    st.counters["ct/s"] = benchmark::Counter(double(batch), benchmark::Counter::kIsIterationInvariantRate);
+}
+
 // the first arg changes first
 BENCHMARK_REGISTER_F(MyFixture, SignTest)->ArgsProduct({benchmark::CreateDenseRange(13, 29, 1), benchmark::CreateDenseRange(0, param_sets.size() - 1, 1)})->Repetitions(1);
+BENCHMARK_REGISTER_F(MyFixture, BatchDecompTest)->ArgsProduct({benchmark::CreateDenseRange(13, 29, 4), {256, 4096}})->Iterations(1);
 BENCHMARK_MAIN();
@@ -190,17 +190,9 @@ int main(int argc, char **argv)
 
         auto t_start = std::chrono::steady_clock::now();
         auto ct1 = cc.Encrypt(sk, m, FRESH, p, param_set.qin);
-        // only decomp algorithms is refractored, because sign & relu can be computed using decomp
-        auto decomp_vec = cc.EvalDecompNew(ct1);
-        LWECiphertext ct_msd = decomp_vec[decomp_vec.size() - 1];
-
-        // XXX: debug
-        // LWEPlaintext dbg;
-        // cc.Decrypt(sk, ct_msd, &dbg, 2);
-        // std::cout << "ct_sgn = " << dbg << "\n";
-        // debug
-
-        auto ct_relu = cc.EvalReLU(ct1, ct_msd, 1 << 27, param_set.relu_baseG);
+        // only the most significant digit is needed: EvalReLULarge runs the reduction chain of EvalDecompNew without
+        // keeping the lower digits, and packs ct1 while the digit is extracted
+        auto ct_relu = cc.EvalReLULarge(ct1, 1 << 27, param_set.relu_baseG);
 
         auto t_end = std::chrono::steady_clock::now();
         std::cout << "time elapsed = " << (t_end - t_start).count() << " ns\n";
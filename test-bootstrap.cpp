@@ -0,0 +1,259 @@
+//==================================================================================
+// BSD 2-Clause License
+//
+// Copyright (c) 2014-2022, NJIT, Duality Technologies Inc. and other contributors
+//
+// All rights reserved.
+//
+// Author TPOC: contact@openfhe.org
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this
+//    list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//==================================================================================
+
+/*
+  Tests of the batched and precomputed bootstrapping paths against their reference results
+ */
+
+#include <binfhe/binfhecontext.h>
+#include <binfhe/binfhecontext-ser.h>
+
+using namespace lbcrypto;
+
+NativeInteger Q26 = PreviousPrime<NativeInteger>(FirstPrime<NativeInteger>(26, 1 << 11), 1 << 11);
+
+static bool check(bool ok, const std::string &name)
+{
+    std::cout << (ok ? "[PASS] " : "[FAIL] ") << name << '\n';
+    return ok;
+}
+
+// a standalone scheme with the ring of the tiny FDFB-Select parameters of eval-func.cpp (N = 1024, Q = Q26)
+struct BTSetup
+{
+    std::shared_ptr<BinFHECryptoParams> params;
+    BinFHEScheme scheme;
+    LWEEncryptionScheme lwe;
+    LWEPrivateKey sk, skN;
+    RingGSWBTKey EK;
+
+    BTSetup(uint32_t n, BINFHE_METHOD method, uint32_t baseR = 0, NativeInteger P = 0, uint32_t baseRL = 0)
+        : scheme(method)
+    {
+        uint32_t N      = 1 << 10;
+        auto lweparams  = std::make_shared<LWECryptoParams>(n, N, 1 << 11, Q26, 1 << 20, 3.19, 1 << 5);
+        auto rgswparams = std::make_shared<RingGSWCryptoParams>(N, Q26, 1 << 11, 1 << 5, baseR, method, 3.19, false, 0,
+                                                                1 << 15, 0, 0, std::vector<uint32_t>{}, 0, P, baseRL);
+        params = std::make_shared<BinFHECryptoParams>(lweparams, rgswparams, false);
+        sk     = lwe.KeyGen(n, lweparams->Getq());
+        skN    = lwe.KeyGen(N, Q26);
+        EK     = scheme.KeyGen(params, sk, skN, nullptr);
+    }
+
+    std::shared_ptr<RingGSWCryptoParams> rgsw() const
+    {
+        return params->GetRingGSWParams();
+    }
+
+    // a random RLWE ciphertext, in evaluation form unless format says otherwise
+    RLWECiphertext random_rlwe(Format format = Format::EVALUATION) const
+    {
+        DiscreteUniformGeneratorImpl<NativeVector> dug;
+        dug.SetModulus(Q26);
+        std::vector<NativePoly> polys(2, NativePoly(rgsw()->GetPolyParams(), format, true));
+        for (auto &poly : polys)
+            poly.SetValues(dug.GenerateVector(rgsw()->GetN(), Q26), format);
+        return std::make_shared<RLWECiphertextImpl>(std::move(polys));
+    }
+};
+
+static bool same(ConstRLWECiphertext a, ConstRLWECiphertext b)
+{
+    return a->GetElements() == b->GetElements();
+}
+
+// EvalAccBatch rotates every accumulator exactly as EvalAcc does on its own, for CGGI and DM
+static bool test_eval_acc_batch()
+{
+    bool ok = true;
+    for (auto method : {GINX, AP})
+    {
+        // DM keys hold n * baseR * digitsR RGSW ciphertexts, so DM runs with a small n
+        BTSetup s(method == GINX ? 760 : 16, method, method == GINX ? 0 : 4);
+        std::shared_ptr<RingGSWAccumulator> acc_scheme;
+        if (method == GINX)
+            acc_scheme = std::make_shared<RingGSWAccumulatorCGGI>();
+        else
+            acc_scheme = std::make_shared<RingGSWAccumulatorDM>();
+
+        std::vector<RLWECiphertext> accs, batch;
+        std::vector<ConstLWECiphertext> cts;
+        for (uint32_t j = 0; j < 5; j++)
+        {
+            accs.push_back(s.random_rlwe());
+            batch.push_back(std::make_shared<RLWECiphertextImpl>(*accs.back()));
+            cts.push_back(s.lwe.Encrypt(s.params->GetLWEParams(), s.sk, j, 16, 2 * s.rgsw()->GetN()));
+        }
+        s.scheme.EvalAccBatch(s.params, s.EK.BSkey, batch, cts);
+        bool batch_ok = true;
+        for (size_t j = 0; j < cts.size(); j++)
+        {
+            acc_scheme->EvalAcc(s.rgsw(), s.EK.BSkey, accs[j], cts[j]->GetA());
+            batch_ok &= same(accs[j], batch[j]);
+        }
+        ok &= check(batch_ok, std::string("EvalAccBatch vs EvalAcc") + (method == GINX ? " (CGGI)" : " (DM)"));
+    }
+    return ok;
+}
+
+// BFVMultBatch, which extends every distinct operand once and shares it between pairs, gives the products of
+// separate BFVMult calls, serial and multithreaded
+static bool test_bfv_mult_batch()
+{
+    BTSetup s(760, GINX, 0, FirstPrime<NativeInteger>(26, 1 << 11), 1 << 13);
+    uint32_t p = 16;
+
+    std::vector<RLWECiphertext> ops;
+    for (uint32_t j = 0; j < 3; j++)
+        ops.push_back(s.random_rlwe(Format::COEFFICIENT));
+    // repeated and self-paired operands, ct1 is extended and ct2 mod switched, so (a, a) uses a twice
+    std::vector<std::pair<RLWECiphertext, RLWECiphertext>> pairs = {
+        {ops[0], ops[1]}, {ops[0], ops[2]}, {ops[1], ops[2]}, {ops[0], ops[1]}, {ops[2], ops[2]}};
+
+    bool ok = true;
+    for (bool multithread : {false, true})
+    {
+        auto params = std::make_shared<BinFHECryptoParams>(s.params->GetLWEParams(), s.rgsw(), multithread);
+        auto batch  = s.scheme.BFVMultBatch(params, s.EK, pairs, p);
+        bool batch_ok = batch.size() == pairs.size();
+        for (size_t i = 0; batch_ok && i < pairs.size(); i++)
+        {
+            // copies, so nothing is shared with other pairs
+            auto ct1 = std::make_shared<RLWECiphertextImpl>(*pairs[i].first);
+            auto ct2 = std::make_shared<RLWECiphertextImpl>(*pairs[i].second);
+            batch_ok &= same(s.scheme.BFVMult(params, s.EK, ct1, ct2, p), batch[i]);
+        }
+        ok &= check(batch_ok, std::string("BFVMultBatch vs BFVMult") + (multithread ? " (multithreaded)" : ""));
+    }
+    return ok;
+}
+
+// poly * X^b by moving the coefficients, poly in coefficient form
+static NativePoly rotate(const NativePoly &poly, uint64_t b)
+{
+    uint32_t N = poly.GetLength();
+    auto &Q    = poly.GetModulus();
+    NativePoly res(poly.GetParams(), Format::COEFFICIENT, true);
+    for (uint32_t i = 0; i < N; i++)
+    {
+        uint64_t k = (i + b) % (2 * N);
+        if (k < N)
+            res[k] = poly[i];
+        else
+            res[k - N] = NativeInteger(0).ModSub(poly[i], Q);
+    }
+    return res;
+}
+
+// MonomialMulEq in evaluation form rotates as the coefficient form does, also with deserialized parameters, whose
+// monomial tables are rebuilt by load()
+static bool test_monomial_mul()
+{
+    auto rgsw = std::make_shared<RingGSWCryptoParams>(1 << 10, Q26, 1 << 11, 1 << 5, 0, GINX, 3.19, false, 0, 1 << 15,
+                                                      0, 0, std::vector<uint32_t>{}, 0, 0, 0);
+    std::stringstream ss;
+    Serial::Serialize(rgsw, ss, SerType::BINARY);
+    std::shared_ptr<RingGSWCryptoParams> loaded;
+    Serial::Deserialize(loaded, ss, SerType::BINARY);
+
+    uint32_t N = rgsw->GetN();
+    DiscreteUniformGeneratorImpl<NativeVector> dug;
+    dug.SetModulus(Q26);
+    bool ok = true;
+    for (auto &params : {rgsw, loaded})
+    {
+        bool rot_ok = true;
+        for (uint64_t b : {uint64_t(0), uint64_t(1), uint64_t(N - 1), uint64_t(N), uint64_t(N + 3), uint64_t(2 * N - 1),
+                           uint64_t(2 * N + 5)})
+        {
+            NativePoly poly(params->GetPolyParams(), Format::COEFFICIENT, true);
+            poly.SetValues(dug.GenerateVector(N, Q26), Format::COEFFICIENT);
+            auto expected = rotate(poly, b);
+            expected.SetFormat(Format::EVALUATION);
+
+            auto coef = poly;
+            BinFHEScheme::MonomialMulEq(params, coef, b);
+            auto eval = poly;
+            eval.SetFormat(Format::EVALUATION);
+            BinFHEScheme::MonomialMulEq(params, eval, b);
+            rot_ok &= coef == expected && eval == expected;
+        }
+        ok &= check(rot_ok, std::string("MonomialMulEq vs coefficient rotation") + (params == loaded ? " (loaded)" : ""));
+    }
+    return ok;
+}
+
+static bool same(ConstLWECiphertext a, ConstLWECiphertext b)
+{
+    return a->GetA() == b->GetA() && a->GetB() == b->GetB() && a->GetModulus() == b->GetModulus();
+}
+
+// the level-synchronous EvalDecompNew of a batch gives every ciphertext the digits of the single-ciphertext call,
+// with the HomDecomp-Reduce parameters of eval-sign.cpp and two levels (B_g = 2^18, 2^27)
+static bool test_decomp_new_batch()
+{
+    NativeInteger Q53 = PreviousPrime<NativeInteger>(FirstPrime<NativeInteger>(53, 1 << 12), 1 << 12);
+    std::vector<uint32_t> baseGs{1 << 18, 1 << 27};
+    uint64_t qin = uint64_t(1) << 21;
+    BinFHEContext cc;
+    cc.GenerateBinFHEContext(1340, 1 << 11, 1 << 12, Q53, uint64_t(1) << 35, 3.19, 1 << 5, baseGs[0], 0, 0, 0, 0, 0, 0,
+                             16, baseGs, 0, false, 0, 0, GINX);
+    auto sk = cc.KeyGen();
+    cc.BTKeyGen(sk);
+
+    int p = cc.GetMaxPlaintextSpace().ConvertToInt() * (qin >> 12);
+    DiscreteUniformGeneratorImpl<NativeVector> dug;
+    dug.SetModulus(p);
+    std::vector<ConstLWECiphertext> cts;
+    for (uint32_t j = 0; j < 5; j++)
+        cts.push_back(cc.Encrypt(sk, dug.GenerateInteger().ConvertToInt(), FRESH, p, qin));
+
+    auto batch = cc.EvalDecompNew(cts);
+    bool ok = batch.size() == cts.size();
+    for (size_t j = 0; ok && j < cts.size(); j++)
+    {
+        auto digits = cc.EvalDecompNew(cts[j]);
+        ok &= digits.size() == batch[j].size();
+        for (size_t i = 0; ok && i < digits.size(); i++)
+            ok &= same(digits[i], batch[j][i]);
+    }
+    return check(ok, "EvalDecompNew batch vs single");
+}
+
+int main()
+{
+    bool ok = true;
+    ok &= test_eval_acc_batch();
+    ok &= test_bfv_mult_batch();
+    ok &= test_monomial_mul();
+    ok &= test_decomp_new_batch();
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,126 @@
+//==================================================================================
+// BSD 2-Clause License
+//
+// Copyright (c) 2014-2022, NJIT, Duality Technologies Inc. and other contributors
+//
+// All rights reserved.
+//
+// Author TPOC: contact@openfhe.org
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this
+//    list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//==================================================================================
+
+/*
+  Tests of the deferred circuit evaluation against evaluating its gates one by one
+ */
+
+#include <binfhe/binfhecontext.h>
+#include <binfhe/binfhe-circuit.h>
+
+using namespace lbcrypto;
+
+NativeInteger Q53 = PreviousPrime<NativeInteger>(FirstPrime<NativeInteger>(53, 1 << 12), 1 << 12);
+
+static bool check(bool ok, const std::string &name)
+{
+    std::cout << (ok ? "[PASS] " : "[FAIL] ") << name << '\n';
+    return ok;
+}
+
+static LWEPlaintext decrypt(BinFHEContext &cc, ConstLWEPrivateKey sk, ConstLWECiphertext ct, uint32_t p)
+{
+    LWEPlaintext result;
+    cc.Decrypt(sk, ct, &result, p);
+    return result;
+}
+
+// duplicated gates share a node, LUTs, FDFB-Select and ReLU gates sharing their input are merged into one task, and
+// the results decrypt to the same values as the gates evaluated one by one
+static bool test_circuit_merge()
+{
+    // the ReLU parameters of eval-relu.cpp, with the packing keys of both FDFB-Select and ReLU
+    BinFHEContext cc;
+    cc.GenerateBinFHEContext(1340, 1 << 11, 1 << 12, Q53, uint64_t(1) << 35, 3.19, 1 << 5, 1 << 18, 0, 1 << 5,
+                             uint64_t(1) << 35, 0, 0, 0, 16, {1 << 18, 1 << 27},
+                             RingGSWCryptoParams::PKKEY_HALF | RingGSWCryptoParams::PKKEY_HALF_TRANS, false, 0, 0,
+                             GINX);
+    auto sk = cc.KeyGen();
+    cc.BTKeyGen(sk);
+
+    uint32_t p = 16, p_large = 1 << 10, qin = 1 << 28;
+    std::vector<NativeInteger> lut1(p), lut2(p);
+    for (uint32_t m = 0; m < p; m++)
+    {
+        lut1[m] = (3 * m + 1) % p;
+        lut2[m] = (m * m) % p;
+    }
+    // EvalLUT needs a message in [0, p/2), FDFB-Select takes the full domain
+    auto ct_half = cc.Encrypt(sk, 5, FRESH, p);
+    auto ct_full = cc.Encrypt(sk, 11, FRESH, p);
+    // two large-precision inputs with the same most significant digit
+    auto ct_large1 = cc.Encrypt(sk, 300, FRESH, p_large, qin);
+    auto ct_large2 = cc.Encrypt(sk, 301, FRESH, p_large, qin);
+    auto ct_msd    = cc.EvalMSD(ct_large1);
+
+    BinFHECircuit circuit(cc);
+    auto x = circuit.Input(ct_half), y = circuit.Input(ct_full);
+    auto big1 = circuit.Input(ct_large1), big2 = circuit.Input(ct_large2), msd = circuit.Input(ct_msd);
+    auto lut_a = circuit.EvalLUT(x, lut1), lut_b = circuit.EvalLUT(x, lut2);
+    auto sel_a = circuit.EvalFDFB(y, FDFBMethod::SELECT, lut1), sel_b = circuit.EvalFDFB(y, FDFBMethod::SELECT, lut2);
+    auto relu1 = circuit.EvalReLU(big1, msd, 1 << 27, 1 << 27), relu2 = circuit.EvalReLU(big2, msd, 1 << 27, 1 << 27);
+    auto sum   = circuit.Add(lut_a, lut_b);
+    bool dedup_ok = circuit.EvalLUT(x, lut1) == lut_a && circuit.EvalFDFB(y, FDFBMethod::SELECT, lut2) == sel_b &&
+                    circuit.EvalReLU(big1, msd, 1 << 27, 1 << 27) == relu1 && circuit.Add(lut_b, lut_a) == sum &&
+                    circuit.Input(ct_half) == x && circuit.GetNodeCount() == 12;
+    bool ok = check(dedup_ok, "duplicated gates share a node");
+
+    auto res = circuit.Execute({lut_a, lut_b, sel_a, sel_b, relu1, relu2, sum});
+    // level 0: the 5 inputs; level 1: one task each for the LUTs, the selections and the ReLUs; level 2: the sum
+    ok &= check(circuit.GetTaskCount() == 9, "gates sharing their input are merged");
+
+    auto ref_lut = cc.EvalMultiFunc(ct_half, {lut1, lut2});
+    std::vector<LWEPlaintext> expected{
+        decrypt(cc, sk, ref_lut[0], p),
+        decrypt(cc, sk, ref_lut[1], p),
+        decrypt(cc, sk, cc.EvalFuncSelect(ct_full, lut1), p),
+        decrypt(cc, sk, cc.EvalFuncSelect(ct_full, lut2), p),
+        decrypt(cc, sk, cc.EvalReLU(ct_large1, ct_msd, 1 << 27, 1 << 27), p_large),
+        decrypt(cc, sk, cc.EvalReLU(ct_large2, ct_msd, 1 << 27, 1 << 27), p_large),
+    };
+    expected.push_back((expected[0] + expected[1]) % p);
+    std::vector<uint64_t> values{lut1[5].ConvertToInt(), lut2[5].ConvertToInt(), lut1[11].ConvertToInt(),
+                                 lut2[11].ConvertToInt(), 300, 301, (lut1[5] + lut2[5]).ConvertToInt() % p};
+    bool eval_ok = res.size() == expected.size();
+    for (size_t k = 0; eval_ok && k < res.size(); k++)
+    {
+        uint32_t mod = (k == 4 || k == 5) ? p_large : p;
+        eval_ok &= decrypt(cc, sk, res[k], mod) == expected[k] && static_cast<uint64_t>(expected[k]) == values[k];
+    }
+    return ok & check(eval_ok, "merged circuit vs gates one by one");
+}
+
+int main()
+{
+    bool ok = true;
+    ok &= test_circuit_merge();
+    return ok ? 0 : 1;
+}
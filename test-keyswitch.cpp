@@ -0,0 +1,317 @@
+//==================================================================================
+// BSD 2-Clause License
+//
+// Copyright (c) 2014-2022, NJIT, Duality Technologies Inc. and other contributors
+//
+// All rights reserved.
+//
+// Author TPOC: contact@openfhe.org
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this
+//    list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//==================================================================================
+
+/*
+  Tests of the key switching and packing paths against their reference results
+ */
+
+#include <binfhe/binfhecontext.h>
+#include <binfhe/binfhecontext-ser.h>
+
+using namespace lbcrypto;
+
+NativeInteger Q26 = PreviousPrime<NativeInteger>(FirstPrime<NativeInteger>(26, 1 << 11), 1 << 11);
+
+static bool check(bool ok, const std::string &name)
+{
+    std::cout << (ok ? "[PASS] " : "[FAIL] ") << name << '\n';
+    return ok;
+}
+
+// the tiny FDFB-Select parameters of eval-func.cpp (p = 16), with the given packing keys
+static void generate_select_context(BinFHEContext &cc, uint32_t pkkey_flags, bool multithread = false)
+{
+    cc.GenerateBinFHEContext(760, 1 << 10, 1 << 11, Q26, 1 << 20, 3.19, 1 << 5, 1 << 5, 0,
+                             1 << 5, 1 << 15, 0, 0, 53, 16, {}, pkkey_flags, multithread, 0, 0, GINX);
+}
+
+// packing with a seeded key (A regenerated from the seed) decrypts to the same values as with a stored key
+static bool test_seeded_packing()
+{
+    BinFHEContext cc, cc_seeded;
+    generate_select_context(cc, RingGSWCryptoParams::PKKEY_HALF);
+    generate_select_context(cc_seeded, RingGSWCryptoParams::PKKEY_HALF | RingGSWCryptoParams::PKKEY_SEEDED);
+    // both contexts share the LWE parameters, so they can share the secret key and the ciphertexts
+    auto sk = cc.KeyGen();
+    cc.BTKeyGen(sk);
+    cc_seeded.BTKeyGen(sk);
+
+    uint32_t p = 16;
+    std::vector<NativeInteger> lut(p);
+    for (uint32_t m = 0; m < p; m++)
+        lut[m] = (3 * m + 5) % p;
+    bool ok = true;
+    for (uint32_t m = 0; m < p; m++)
+    {
+        auto ct = cc.Encrypt(sk, m, FRESH, p);
+        LWEPlaintext result, result_seeded;
+        cc.Decrypt(sk, cc.EvalFuncSelect(ct, lut, 0, 0, 0, nullptr, 1 << 5), &result, p);
+        cc_seeded.Decrypt(sk, cc_seeded.EvalFuncSelect(ct, lut, 0, 0, 0, nullptr, 1 << 5), &result_seeded, p);
+        ok &= result == result_seeded && static_cast<uint64_t>(result) == lut[m].ConvertToInt();
+    }
+    return check(ok, "seeded vs stored packing key");
+}
+
+// standalone LWE key switching from (qKS,N) to (qKS,n), with the dimensions of the FDFB-Select parameters
+// SetKSThreads reaches the parameters without touching the others, and the packing key switch split over that
+// many threads gives the same results as with the default
+static bool test_ks_threads()
+{
+    BinFHEContext cc, cc_threads;
+    generate_select_context(cc, RingGSWCryptoParams::PKKEY_HALF, true);
+    generate_select_context(cc_threads, RingGSWCryptoParams::PKKEY_HALF, true);
+    cc_threads.SetFailureProbability(1.0 / (uint64_t(1) << 40));
+    cc_threads.SetKSThreads(3);
+    auto params = cc_threads.GetParams();
+    bool ok     = check(params->GetKSThreads() == 3 && cc.GetParams()->GetKSThreads() == 0 &&
+                            params->GetMultithread() &&
+                            params->GetFailureProbability() == 1.0 / (uint64_t(1) << 40) &&
+                            params->GetLWEParams() == cc.GetParams()->GetLWEParams(),
+                        "SetKSThreads sets the parameters");
+
+    auto sk = cc.KeyGen();
+    cc.BTKeyGen(sk);
+    cc_threads.BTKeyGen(sk);
+    uint32_t p = 16;
+    std::vector<NativeInteger> lut(p);
+    for (uint32_t m = 0; m < p; m++)
+        lut[m] = (5 * m + 3) % p;
+    bool eval_ok = true;
+    for (uint32_t m = 0; m < p; m++)
+    {
+        auto ct = cc.Encrypt(sk, m, FRESH, p);
+        LWEPlaintext result, result_threads;
+        cc.Decrypt(sk, cc.EvalFuncSelect(ct, lut, 0, 0, 0, nullptr, 1 << 5), &result, p);
+        cc_threads.Decrypt(sk, cc_threads.EvalFuncSelect(ct, lut, 0, 0, 0, nullptr, 1 << 5), &result_threads, p);
+        eval_ok &= result == result_threads && static_cast<uint64_t>(result) == lut[m].ConvertToInt();
+    }
+    return ok & check(eval_ok, "packing key switch with 3 threads");
+}
+
+struct KSSetup
+{
+    std::shared_ptr<LWECryptoParams> params;
+    LWEEncryptionScheme scheme;
+    LWEPrivateKey sk, skN;
+    LWESwitchingKey K;
+
+    explicit KSSetup(const NativeInteger &qKS)
+        : params(std::make_shared<LWECryptoParams>(760, 1 << 10, 1 << 11, Q26, qKS, 3.19, 1 << 5))
+    {
+        sk  = scheme.KeyGen(params->Getn(), params->Getq());
+        skN = scheme.KeyGen(params->GetN(), params->GetQ());
+        K   = scheme.KeySwitchGen(params, sk, skN);
+    }
+
+    // fresh encryptions of 0, ..., count - 1 under (qKS,N)
+    std::vector<LWECiphertext> encrypt(size_t count, uint32_t p)
+    {
+        std::vector<LWECiphertext> cts;
+        for (size_t m = 0; m < count; m++)
+            cts.push_back(scheme.Encrypt(params, skN, m % p, p, params->GetqKS()));
+        return cts;
+    }
+};
+
+static bool same(ConstLWECiphertext a, ConstLWECiphertext b)
+{
+    return a->GetModulus() == b->GetModulus() && a->GetA() == b->GetA() && a->GetB() == b->GetB();
+}
+
+// key switching directly on the nested key, as before the flat layout
+static LWECiphertext nested_keyswitch(const KSSetup &s, ConstLWECiphertext ctQN)
+{
+    NativeInteger qKS   = s.params->GetqKS();
+    uint32_t baseKS     = s.params->GetBaseKS();
+    uint32_t digitCount = (uint32_t)std::ceil(log(qKS.ConvertToDouble()) / log(static_cast<double>(baseKS)));
+    auto &A             = s.K->GetElementsA();
+    auto &B             = s.K->GetElementsB();
+    NativeVector a(s.params->Getn(), qKS);
+    NativeInteger b = ctQN->GetB();
+    for (size_t i = 0; i < s.params->GetN(); i++)
+    {
+        NativeInteger atmp = ctQN->GetA(i);
+        for (size_t j = 0; j < digitCount; j++, atmp /= baseKS)
+        {
+            uint32_t a0 = (atmp % baseKS).ConvertToInt();
+            if (a0 == 0)
+                continue;
+            a.ModSubEq(A[i][a0][j]);
+            b.ModSubFastEq(B[i][a0][j], qKS);
+        }
+    }
+    return std::make_shared<LWECiphertextImpl>(LWECiphertextImpl(std::move(a), b));
+}
+
+// KeySwitch over the flat key matches the nested key, for a power-of-two (narrow) and an odd qKS, and
+// KeySwitchBatch (more than one block of inputs) matches KeySwitch
+static bool test_flat_keyswitch()
+{
+    bool ok = true;
+    for (auto qKS : {NativeInteger(1 << 20), PreviousPrime<NativeInteger>(NativeInteger(1 << 20), 2)})
+    {
+        KSSetup s(qKS);
+        auto cts   = s.encrypt(11, 16);
+        auto batch = s.scheme.KeySwitchBatch(s.params, s.K, cts);
+        bool flat_ok = true, batch_ok = batch.size() == cts.size();
+        for (size_t m = 0; m < cts.size(); m++)
+        {
+            auto ct = s.scheme.KeySwitch(s.params, s.K, cts[m]);
+            LWEPlaintext result;
+            s.scheme.Decrypt(s.params, s.sk, ct, &result, 16);
+            flat_ok &= same(ct, nested_keyswitch(s, cts[m])) && static_cast<size_t>(result) == m % 16;
+            batch_ok &= m < batch.size() && same(batch[m], ct);
+        }
+        std::string name = qKS.ConvertToInt() == (1 << 20) ? " (qKS = 2^20)" : " (odd qKS)";
+        ok &= check(flat_ok, "flat vs nested KeySwitch" + name);
+        ok &= check(batch_ok, "KeySwitchBatch vs KeySwitch" + name);
+
+        // a replaced key is picked up by the next key switch
+        auto B = s.K->GetElementsB();
+        for (auto &row : B)
+            for (auto &digits : row)
+                for (auto &b : digits)
+                    b.ModAddFastEq(1, qKS);
+        s.K->SetElementsB(B);
+        auto ct = s.scheme.KeySwitch(s.params, s.K, cts[0]);
+        ok &= check(same(ct, nested_keyswitch(s, cts[0])), "flat key rebuilt after SetElementsB" + name);
+
+        // a flattened key only keeps the flat layout; it gives back the nested key and survives serialization
+        auto flattened = std::make_shared<LWESwitchingKeyImpl>(*s.K);
+        flattened->Flatten();
+        std::stringstream ss;
+        Serial::Serialize(flattened, ss, SerType::BINARY);
+        LWESwitchingKey loaded;
+        Serial::Deserialize(loaded, ss, SerType::BINARY);
+        ok &= check(flattened->GetElementsA() == s.K->GetElementsA() &&
+                        flattened->GetElementsB() == s.K->GetElementsB() && *loaded == *s.K &&
+                        same(s.scheme.KeySwitch(s.params, loaded, cts[0]), ct),
+                    "flattened and deserialized key" + name);
+    }
+    return ok;
+}
+
+// the fused ModSwitchKeySwitch matches ModSwitch(qKS) -> KeySwitch -> ModSwitch(qout) done as separate steps
+static bool test_fused_keyswitch()
+{
+    bool ok = true;
+    for (auto qKS : {NativeInteger(1 << 20), PreviousPrime<NativeInteger>(NativeInteger(1 << 20), 2)})
+    {
+        KSSetup s(qKS);
+        bool fused_ok = true;
+        for (uint32_t m = 0; m < 16; m++)
+        {
+            auto ctQ = s.scheme.Encrypt(s.params, s.skN, m, 16, s.params->GetQ());
+            for (auto qout : {s.params->Getq(), qKS})
+            {
+                auto fused    = s.scheme.ModSwitchKeySwitch(s.params, s.K, ctQ, qout);
+                auto separate = s.scheme.ModSwitchExact(
+                    qout, s.scheme.KeySwitch(s.params, s.K, s.scheme.ModSwitchExact(qKS, ctQ)));
+                LWEPlaintext result;
+                s.scheme.Decrypt(s.params, s.sk, fused, &result, 16);
+                fused_ok &= same(fused, separate) && static_cast<uint32_t>(result) == m;
+            }
+        }
+        std::string name = qKS.ConvertToInt() == (1 << 20) ? " (qKS = 2^20)" : " (odd qKS)";
+        ok &= check(fused_ok, "fused vs separate ModSwitch-KeySwitch-ModSwitch" + name);
+    }
+    return ok;
+}
+
+// KeySwitchMultBatch (more than one block of inputs) matches KeySwitchMult
+static bool test_mult_keyswitch_batch()
+{
+    bool ok = true;
+    for (auto qKS : {NativeInteger(1 << 20), PreviousPrime<NativeInteger>(NativeInteger(1 << 20), 2)})
+    {
+        KSSetup s(qKS);
+        auto K     = s.scheme.KeySwitchGenMult(s.params, s.sk, s.skN);
+        auto cts   = s.encrypt(11, 16);
+        auto batch = s.scheme.KeySwitchMultBatch(s.params, K, cts);
+        bool batch_ok = batch.size() == cts.size();
+        for (size_t m = 0; m < cts.size(); m++)
+        {
+            auto ct = s.scheme.KeySwitchMult(s.params, K, cts[m]);
+            LWEPlaintext result;
+            s.scheme.Decrypt(s.params, s.sk, ct, &result, 16);
+            batch_ok &= m < batch.size() && same(batch[m], ct) && static_cast<size_t>(result) == m % 16;
+        }
+        std::string name = qKS.ConvertToInt() == (1 << 20) ? " (qKS = 2^20)" : " (odd qKS)";
+        ok &= check(batch_ok, "KeySwitchMultBatch vs KeySwitchMult" + name);
+    }
+    return ok;
+}
+
+// ModSwitchExact rounds as ModSwitch does at power-of-two moduli (where the double arithmetic of ModSwitch is exact),
+// switching down, up and to the same modulus, including the values halfway between two results
+static bool test_modswitch_exact()
+{
+    LWEEncryptionScheme scheme;
+    std::vector<std::pair<uint64_t, uint64_t>> moduli = {{uint64_t(1) << 20, 1 << 11},
+                                                         {uint64_t(1) << 35, uint64_t(1) << 20},
+                                                         {uint64_t(1) << 53, 1 << 12},
+                                                         {1 << 11, 1 << 11},
+                                                         {1 << 11, uint64_t(1) << 20}};
+    bool ok = true;
+    for (auto &mod : moduli)
+    {
+        NativeInteger Q(mod.first), q(mod.second);
+        DiscreteUniformGeneratorImpl<NativeVector> dug;
+        dug.SetModulus(Q);
+        NativeVector a = dug.GenerateVector(760, Q);
+        a[0]           = 0;
+        a[1]           = Q - 1;
+        a[2]           = Q >> 1;
+        if (Q > q)
+        {
+            // halfway cases, (2k + 1) * Q / 2q
+            uint64_t half = mod.first / mod.second / 2;
+            a[3]          = half;
+            a[4]          = 3 * half;
+            a[5]          = Q - half;
+        }
+        auto ct = std::make_shared<LWECiphertextImpl>(LWECiphertextImpl(std::move(a), dug.GenerateInteger()));
+        ok &= same(scheme.ModSwitch(q, ct), scheme.ModSwitchExact(q, ct));
+    }
+    return check(ok, "ModSwitchExact vs ModSwitch (power-of-two moduli)");
+}
+
+int main()
+{
+    bool ok = true;
+    ok &= test_seeded_packing();
+    ok &= test_ks_threads();
+    ok &= test_flat_keyswitch();
+    ok &= test_fused_keyswitch();
+    ok &= test_mult_keyswitch_batch();
+    ok &= test_modswitch_exact();
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,130 @@
+//==================================================================================
+// BSD 2-Clause License
+//
+// Copyright (c) 2014-2022, NJIT, Duality Technologies Inc. and other contributors
+//
+// All rights reserved.
+//
+// Author TPOC: contact@openfhe.org
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this
+//    list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//==================================================================================
+
+/*
+  Tests of the SIMD lazy accumulation kernels against the scalar kernels
+ */
+
+#include <binfhe/binfhecontext.h>
+#include <core/math/hal/intnat/lazyvecops.h>
+#include <random>
+
+using namespace lbcrypto;
+using intnat::LazyKernelISA;
+
+typedef std::vector<uint64_t> Vec;
+
+static bool check(bool ok, const std::string &name)
+{
+    std::cout << (ok ? "[PASS] " : "[FAIL] ") << name << '\n';
+    return ok;
+}
+
+static Vec random_vec(std::mt19937_64 &rng, size_t n, uint64_t bound = 0)
+{
+    Vec v(n);
+    for (auto &x : v)
+        x = bound ? rng() % bound : rng();
+    return v;
+}
+
+// runs all kernels under the given instruction set on fixed inputs and returns their outputs
+static std::vector<Vec> run_kernels(LazyKernelISA isa, size_t n, uint64_t q)
+{
+    intnat::SetLazyKernelISA(isa);
+    std::mt19937_64 rng(n ^ q);
+    std::vector<Vec> out;
+    auto a = random_vec(rng, n), b = random_vec(rng, n);
+
+    Vec r = a;
+    intnat::LazyAddEq(r.data(), b.data(), n);
+    out.push_back(r);
+    r = a;
+    intnat::LazyAddEq(r.data(), b[0], n);
+    out.push_back(r);
+    r = a;
+    intnat::LazySubEq(r.data(), b.data(), n);
+    out.push_back(r);
+    r = a;
+    intnat::LazyMulSubEq(r.data(), b.data(), q - 3, n);
+    out.push_back(r);
+
+    // full 64-bit inputs, with the boundary values up front
+    r = a;
+    uint64_t edges[] = {0, 1, q - 1, q, q + 1, 2 * q - 1, uint64_t(-1) - q, uint64_t(-1)};
+    for (size_t i = 0; i < n && i < 8; i++)
+        r[i] = edges[i];
+    intnat::LazyModReduce(r.data(), q, n);
+    out.push_back(r);
+
+    // the packing loop: subtract rows below q, reducing and refilling every maxCount rows
+    uint64_t maxCount = uint64_t(-1) / q - 1;
+    uint64_t refill = maxCount * q;
+    r.assign(n, refill);
+    uint64_t count = 0;
+    size_t rows = std::min<uint64_t>(2 * maxCount + 3, 64);
+    for (size_t j = 0; j < rows; j++)
+    {
+        auto row = random_vec(rng, n, q);
+        count = intnat::LazySubEqReduce(r.data(), row.data(), n, q, count, std::min<uint64_t>(maxCount, 16), refill);
+    }
+    intnat::LazyModReduce(r.data(), q, n);
+    out.push_back(r);
+    return out;
+}
+
+int main()
+{
+    // a 53-bit NTT prime, a 32-bit modulus, a 60-bit modulus and a modulus below the 2^14 scalar fallback
+    std::vector<uint64_t> moduli = {
+        PreviousPrime<NativeInteger>(FirstPrime<NativeInteger>(53, 1 << 12), 1 << 12).ConvertToInt(),
+        (uint64_t(1) << 32) - 5, (uint64_t(1) << 60) - 93, 12289};
+    // lengths exercising the vector body, the scalar tail and both together
+    std::vector<size_t> lengths = {1, 7, 8, 1029, 1 << 11};
+
+    bool ok = true;
+    for (auto isa : {LazyKernelISA::AVX2, LazyKernelISA::AVX512})
+    {
+        std::string name = isa == LazyKernelISA::AVX2 ? "AVX2" : "AVX-512";
+        intnat::SetLazyKernelISA(isa);
+        if (intnat::GetLazyKernelISA() != isa)
+        {
+            std::cout << "[SKIP] " << name << " vs scalar lazy kernels (not supported by this CPU)\n";
+            continue;
+        }
+        bool same = true;
+        for (auto q : moduli)
+            for (auto n : lengths)
+                same &= run_kernels(isa, n, q) == run_kernels(LazyKernelISA::SCALAR, n, q);
+        ok &= check(same, name + " vs scalar lazy kernels");
+    }
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,100 @@
+//==================================================================================
+// BSD 2-Clause License
+//
+// Copyright (c) 2014-2022, NJIT, Duality Technologies Inc. and other contributors
+//
+// All rights reserved.
+//
+// Author TPOC: contact@openfhe.org
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// 1. Redistributions of source code must retain the above copyright notice, this
+//    list of conditions and the following disclaimer.
+//
+// 2. Redistributions in binary form must reproduce the above copyright notice,
+//    this list of conditions and the following disclaimer in the documentation
+//    and/or other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+// FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+// DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+// SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+// OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//==================================================================================
+
+/*
+  Tests of the gadget base planner against the base selection of param.py
+ */
+
+#include <binfhe/binfhecontext.h>
+#include <binfhe/binfhe-planner.h>
+
+using namespace lbcrypto;
+
+NativeInteger Q53 = PreviousPrime<NativeInteger>(FirstPrime<NativeInteger>(53, 1 << 12), 1 << 12);
+
+static bool check(bool ok, const std::string &name)
+{
+    std::cout << (ok ? "[PASS] " : "[FAIL] ") << name << '\n';
+    return ok;
+}
+
+// log(q) from which the planner picks 2^18 and 2^14 over 2^27, as printed by the loops at the end of param.py
+static std::vector<uint32_t> switch_points(const GadgetBasePlanner &planner, FloorMethod method)
+{
+    std::vector<uint32_t> candidates{1 << 27, 1 << 18, 1 << 14};
+    std::vector<uint32_t> points;
+    uint32_t prev = 1 << 27;
+    for (uint32_t i = 13; i < 40; i++)
+    {
+        uint32_t base = planner.ChooseBaseG(uint64_t(1) << i, method, 128, candidates);
+        if (base != prev)
+            points.push_back(i);
+        prev = base;
+    }
+    return points;
+}
+
+static bool test_plan_dimension()
+{
+    std::vector<FloorMethod> methods{FloorMethod::FLOOR, FloorMethod::FLOOR_ALT, FloorMethod::FLOOR_NEW,
+                                     FloorMethod::FLOOR_COMPRESS};
+    // n = 1340 reproduces param.py (n35), the smaller modulus switching error of n = 760 (n20) moves the later levels
+    std::vector<std::pair<uint32_t, std::vector<std::vector<uint32_t>>>> expected{
+        {1340, {{17, 26}, {20, 28}, {20, 29}, {21, 30}}},
+        {760, {{18, 27}, {20, 29}, {21, 30}, {22, 31}}},
+    };
+    bool ok = true;
+    for (auto &[n, points] : expected)
+    {
+        GadgetBasePlanner planner(n, 1 << 11, Q53, uint64_t(1) << 35, 1 << 5, 3.19);
+        bool plan_ok = true;
+        for (size_t k = 0; k < methods.size(); k++)
+            plan_ok &= switch_points(planner, methods[k]) == points[k];
+        ok &= check(plan_ok, "gadget bases of n = " + std::to_string(n) + " vs param.py");
+    }
+
+    GadgetBasePlanner large(1340, 1 << 11, Q53, uint64_t(1) << 35, 1 << 5, 3.19);
+    GadgetBasePlanner small(760, 1 << 11, Q53, uint64_t(1) << 35, 1 << 5, 3.19);
+    bool bound_ok = true;
+    for (auto method : {FloorMethod::FLOOR_NEW, FloorMethod::FLOOR_COMPRESS})
+        bound_ok &= small.NoiseBound(method, 128) > large.NoiseBound(method, 128) && large.NoiseBound(method, 128) > 0;
+    // no base fits once the modulus switching error alone exceeds the budget
+    GadgetBasePlanner huge(1 << 16, 1 << 11, Q53, uint64_t(1) << 35, 1 << 5, 3.19);
+    bound_ok &= huge.NoiseBound(FloorMethod::FLOOR_NEW, 128) == 0;
+    return ok & check(bound_ok, "noise bound shrinks with n");
+}
+
+int main()
+{
+    bool ok = true;
+    ok &= test_plan_dimension();
+    return ok ? 0 : 1;
+}